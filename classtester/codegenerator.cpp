@@ -5,13 +5,18 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <random>
 #include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
 
-// Configuration of class hierarchies
+// Default configuration of class hierarchies (overridable with -c and -p)
 #define CLASSES 5
 #define PARENTS_PER_CLASS 3
 // Number of variants to generate for random characteristics
 #define RANDOM_VARIANTS 10
+// Number of consecutive invalid hierarchies after which sampling gives up
+#define MAX_SAMPLE_ATTEMPTS 1000
 
 // Define if diamond inheritance is desired
 #define DO_DIAMOND
@@ -33,10 +38,22 @@ using namespace std;
 typedef vector<int> parentVectorTy;
 typedef set<int> parentSetTy;
 typedef vector<string> stringVectorTy;
+typedef vector<unsigned int> orderTy;
+
+// Runtime configuration of class hierarchies
+int classCount = CLASSES;
+int parentsPerClass = PARENTS_PER_CLASS;
+
+// Runtime configuration of sampling mode (enabled by -n)
+// Relative weights of drawing a non-virtual or a virtual parent among the feasible ones
+int sampleCount = 0;
+unsigned int sampleSeed = 0;
+int nonVirtualWeight = 1;
+int virtualWeight = 1;
 
 // Configuration for a given class within the hierarchy
 // directParents is the list of parent classes by ID
-// virtual parents within directParents are signalled by having CLASSES added to their ID
+// virtual parents within directParents are signalled by having classCount added to their ID
 // allVirtualParents and allNonVirtualParents are the sets of parent classes by ID
 struct classConfiguration
 {
@@ -63,15 +80,17 @@ struct classConfiguration
             cc->allVirtualParents.end());;
     }
     // Ordering function to elliminate repetitions while generating combinations
-    unsigned int getOrder()
+    // Compared lexicographically: by number of direct parents first, then by parent entries
+    // Kept as a sequence so that it cannot overflow for large class counts
+    orderTy getOrder()
     {
-        unsigned int result = 0;
+        orderTy result;
+        result.push_back(directParents.size());
         for (int parent : directParents)
         {
-            int entry = (parent % CLASSES + 1);
-            entry *= (parent / CLASSES) + 1;
-            result += entry;
-            result *= (2 * (CLASSES + 1));
+            unsigned int entry = (parent % classCount + 1);
+            entry *= (parent / classCount) + 1;
+            result.push_back(entry);
         }
         return result;
     }
@@ -88,7 +107,7 @@ classConfiguration *checkAndGenerateInheritance(configurationTy &configuration,
 {
     // Direct parents cannot be added a second time
     for (int directParent : currentClass->directParents)
-        if (directParent % CLASSES == parent)
+        if (directParent % classCount == parent)
             return NULL;
 
     // Non-virtual copies of existing virtual parents cannot be added directly
@@ -103,17 +122,17 @@ classConfiguration *checkAndGenerateInheritance(configurationTy &configuration,
     // Existing direct parents cannot conflict with the parents inherited transitively from new candidate
     for (int directParent : currentClass->directParents)
         // Existing non-virtual direct parent cannot also be inherited
-        if (directParent < CLASSES)
+        if (directParent < classCount)
         {
-            if (configuration[parent]->allNonVirtualParents.count(directParent % CLASSES))
+            if (configuration[parent]->allNonVirtualParents.count(directParent % classCount))
                 return NULL;
-            if (configuration[parent]->allVirtualParents.count(directParent % CLASSES))
+            if (configuration[parent]->allVirtualParents.count(directParent % classCount))
                 return NULL;
         }
         else 
         {
             // Existing virtual direct parent cannot also be inherited as non-virtual parent
-            if (configuration[parent]->allNonVirtualParents.count(directParent % CLASSES))
+            if (configuration[parent]->allNonVirtualParents.count(directParent % classCount))
                 return NULL;
         }
 
@@ -123,11 +142,13 @@ classConfiguration *checkAndGenerateInheritance(configurationTy &configuration,
     if (!doVirtual)
         candidateClass->directParents.push_back(parent);
     else
-        candidateClass->directParents.push_back(parent + CLASSES);
+        candidateClass->directParents.push_back(parent + classCount);
     
+#ifndef DO_DIAMOND
     // Track the total parent count to detect diamond inheritance
     int sizeBefore = candidateClass->allNonVirtualParents.size() +
                      candidateClass->allVirtualParents.size();
+#endif
     
     // Update parent lists (both direct and transitively inherited)
     candidateClass->allNonVirtualParents.insert(
@@ -140,14 +161,14 @@ classConfiguration *checkAndGenerateInheritance(configurationTy &configuration,
         candidateClass->allNonVirtualParents.insert(parent);
     else
         candidateClass->allVirtualParents.insert(parent);
-    
+
+#ifndef DO_DIAMOND
     // Tracke the changes in the parent count
     int sizeAfter = candidateClass->allNonVirtualParents.size() +
                      candidateClass->allVirtualParents.size();
     int sizeAdded = configuration[parent]->allNonVirtualParents.size() +
                     configuration[parent]->allVirtualParents.size() + 1;
 
-#ifndef DO_DIAMOND
     // Check the intersection of the sets to detect diamond inheritance
     // Use the union size to short-cut the intersection
     if (sizeBefore + sizeAdded != sizeAfter)
@@ -164,9 +185,9 @@ classConfiguration *checkAndGenerateInheritance(configurationTy &configuration,
 void generateClassConfigurations(configurationTy &configuration, classConfiguration *currentClass, classSolutionVectorTy &solutions)
 {
     solutions.push_back(currentClass);
-    if (currentClass->directParents.size() == PARENTS_PER_CLASS)
+    if (currentClass->directParents.size() == (unsigned int)parentsPerClass)
         return;
-    for (int candidateParent = 0; candidateParent < configuration.size(); ++candidateParent)
+    for (int candidateParent = 0; candidateParent < (int)configuration.size(); ++candidateParent)
     {
         classConfiguration *newClass;
         newClass = checkAndGenerateInheritance(configuration, currentClass, candidateParent, false);
@@ -240,7 +261,7 @@ void accumulateAllCastStrings(configurationTy &configuration, int classId, int t
     stringVectorTy parentStringVector;
     for (int parentId : configuration[classId]->directParents)
     {
-        accumulateAllCastStrings(configuration, parentId % CLASSES, targetClassId, parentStringVector);
+        accumulateAllCastStrings(configuration, parentId % classCount, targetClassId, parentStringVector);
     }
     // Add current class to the casting chain before saving them to the solutions
     for (string parentString : parentStringVector)
@@ -260,7 +281,7 @@ int checkParentCount(configurationTy &configuration, int classId, int parentId)
     int count = 0;
     for (int directParentId : configuration[classId]->directParents)
     {
-        count += checkParentCount(configuration, directParentId % CLASSES, parentId);
+        count += checkParentCount(configuration, directParentId % classCount, parentId);
     }
     return count;
 }
@@ -270,7 +291,7 @@ int checkNonVirtualParentCount(configurationTy &configuration, int classId, int
 {
     if (classId == parentId)
         return 1;
-    classId %= CLASSES;
+    classId %= classCount;
     int count = 0;
     for (int directParentId : configuration[classId]->directParents)
     {
@@ -280,7 +301,8 @@ int checkNonVirtualParentCount(configurationTy &configuration, int classId, int
 }
 
 // Print current class hierarchy into autogenerated source file
-void printHierarchyConfiguration(configurationTy &configuration, int *count)
+// Returns the name of the generated source file
+string printHierarchyConfiguration(configurationTy &configuration, int *count)
 {
     ofstream sourceFile;
     stringstream fileName;
@@ -306,9 +328,9 @@ void printHierarchyConfiguration(configurationTy &configuration, int *count)
             sourceFile << " : ";
         for (int parent :  currentClass->directParents)
         {
-            if (parent >= CLASSES)
+            if (parent >= classCount)
                 sourceFile << "virtual ";
-            sourceFile << "c" << (parent % CLASSES);
+            sourceFile << "c" << (parent % classCount);
             if (parent != currentClass->directParents.back())
                 sourceFile << ", ";
         }
@@ -374,10 +396,10 @@ void printHierarchyConfiguration(configurationTy &configuration, int *count)
     // Main function
     sourceFile << "int main()" << endl << "{" << endl;
     // For each class create each possible object instance of it and test them
-    pos = 0;
-    for (classConfiguration *currentClass : configuration)
+    for (pos = 0; pos < (int)configuration.size(); ++pos)
     {
-        sourceFile << "c" << pos << "* ptrs" << pos << "[" << CLASSES * CLASSES << "];" << endl;
+        // Instances are buffered so that the array can be sized to the number of casting chains
+        stringstream instances;
         int childPos = 0;
         int count = 0;
         for (classConfiguration *childClass : configuration)
@@ -395,21 +417,23 @@ void printHierarchyConfiguration(configurationTy &configuration, int *count)
             accumulateAllCastStrings(configuration, childPos, pos, castStringVector);
             for (string castString : castStringVector)
             {
-                sourceFile << "ptrs" << pos << "[" << count << "] = " << castString << "(new c" << childPos << "());" << endl;
+                instances << "ptrs" << pos << "[" << count << "] = " << castString << "(new c" << childPos << "());" << endl;
                 ++count;
             }
             ++childPos;
         }
+        sourceFile << "c" << pos << "* ptrs" << pos << "[" << count << "];" << endl;
+        sourceFile << instances.str();
         // Call tester and destructor on every generated instance of class
         sourceFile << "for (int i=0;i<" << count << ";i=inc(i))" << endl;
         sourceFile << "{" << endl;
         sourceFile << "tester" << pos << "(ptrs" << pos << "[i]);" << endl;
         sourceFile << "delete ptrs" << pos << "[i];" << endl;
         sourceFile << "}" << endl;
-        pos++;
     }
     sourceFile << "return 0;" << endl << "}" << endl;
     sourceFile.close();
+    return fileName.str();
 }
 
 // Recursive function to generate all valid class hierarchy configurations
@@ -426,13 +450,13 @@ void generateHierarchyConfigurations(configurationTy &configuration, int *count)
         // Generate multiple variants for random characteristics
         for (int i = 0; i < RANDOM_VARIANTS; ++i)
         {
-            printConfiguration(configuration, count);
             ++(*count);
+            printHierarchyConfiguration(configuration, count);
         }
 #endif
     }
     // Hierarchy full, stop
-    if (configuration.size() == CLASSES)
+    if (configuration.size() == (unsigned int)classCount)
         return;
 
     // Generate all configurations for the next class in the hierarchy
@@ -441,15 +465,13 @@ void generateHierarchyConfigurations(configurationTy &configuration, int *count)
     generateClassConfigurations(configuration, initialClass, solutions);
     
     // Find the order of the last class in the hierarchy
-    unsigned int previousOrder;
+    orderTy previousOrder;
     if (configuration.size () > 0)
         previousOrder = configuration.back()->getOrder();
-    else
-        previousOrder = 0;
     // Generate a new class hierarchy for each new class configuration as long as the order is increasing
     for (classConfiguration *currentClass :  solutions)
     {
-        unsigned int order = currentClass->getOrder();
+        orderTy order = currentClass->getOrder();
         if (order < previousOrder)
         {
             delete currentClass;
@@ -462,11 +484,155 @@ void generateHierarchyConfigurations(configurationTy &configuration, int *count)
     }
 }
 
+// Draw a random configuration for the next class in the hierarchy
+// Parents are added one at a time among the candidates accepted by checkAndGenerateInheritance
+// Each feasible candidate is weighted by nonVirtualWeight or virtualWeight
+classConfiguration *sampleClassConfiguration(configurationTy &configuration, mt19937 &generator)
+{
+    classConfiguration *currentClass = new classConfiguration();
+    // The first class is the only root
+    if (configuration.size() == 0)
+        return currentClass;
+    // Every later class inherits from at least one earlier class, which keeps the hierarchy connected
+    uniform_int_distribution<int> parentDistribution(1, parentsPerClass);
+    int parents = parentDistribution(generator);
+    // Candidate 2 * parent stands for non-virtual, 2 * parent + 1 for virtual inheritance
+    vector<int> weights;
+    for (int candidateParent = 0; candidateParent < (int)configuration.size(); ++candidateParent)
+    {
+        weights.push_back(nonVirtualWeight);
+        weights.push_back(virtualWeight);
+    }
+    // Draw candidates until one is accepted, rejected candidates stay infeasible once more parents are added
+    while ((int)currentClass->directParents.size() < parents)
+    {
+        // Stop early if no further parent can be added
+        int totalWeight = 0;
+        for (int weight : weights)
+            totalWeight += weight;
+        if (totalWeight == 0)
+            break;
+        discrete_distribution<int> candidateDistribution(weights.begin(), weights.end());
+        int candidate = candidateDistribution(generator);
+        weights[candidate] = 0;
+        classConfiguration *newClass;
+        newClass = checkAndGenerateInheritance(configuration, currentClass, candidate / 2, candidate % 2);
+        if (!newClass)
+            continue;
+        delete currentClass;
+        currentClass = newClass;
+    }
+    return currentClass;
+}
+
+// Generate sampleCount random class hierarchy configurations from sampleSeed
+// Each source file is written and its name printed as soon as the hierarchy is drawn
+// Hierarchies rejected by checkHierarchyConfiguration are drawn again, up to MAX_SAMPLE_ATTEMPTS times in a row
+void sampleHierarchyConfigurations(int *count)
+{
+    mt19937 generator(sampleSeed);
+    // Random overrides are drawn with rand() while printing
+    srand(sampleSeed);
+    int attempts = 0;
+    while (*count < sampleCount)
+    {
+        configurationTy configuration;
+        for (int pos = 0; pos < classCount; ++pos)
+            configuration.push_back(sampleClassConfiguration(configuration, generator));
+        if (!checkHierarchyConfiguration(configuration))
+        {
+            for (classConfiguration *currentClass : configuration)
+                delete currentClass;
+            if (++attempts == MAX_SAMPLE_ATTEMPTS)
+            {
+                cerr << "No valid hierarchy found in " << MAX_SAMPLE_ATTEMPTS << " attempts." << endl;
+                exit(-1);
+            }
+            continue;
+        }
+        attempts = 0;
+#if !defined(DO_RANDOMOVERRIDE)
+        ++(*count);
+        cout << printHierarchyConfiguration(configuration, count) << endl;
+#else
+        // Generate multiple variants for random characteristics
+        for (int i = 0; i < RANDOM_VARIANTS && *count < sampleCount; ++i)
+        {
+            ++(*count);
+            cout << printHierarchyConfiguration(configuration, count) << endl;
+        }
+#endif
+        for (classConfiguration *currentClass : configuration)
+            delete currentClass;
+    }
+}
+
+// Print command line usage
+void printUsage(char *name)
+{
+    cerr << "Usage: " << name << " [-c classes] [-p parents] [-n samples [-s seed] [-w nonvirtual:virtual]]" << endl;
+    cerr << "  -c : number of classes in the hierarchy (default " << CLASSES << ")" << endl;
+    cerr << "  -p : maximum number of direct parents per class (default " << PARENTS_PER_CLASS << ")" << endl;
+    cerr << "  -n : draw the given number of random hierarchies instead of enumerating all of them" << endl;
+    cerr << "  -s : seed of the random hierarchies (default 0)" << endl;
+    cerr << "  -w : relative weights of non-virtual and virtual parents (default 1:1)" << endl;
+}
+
 // Main
 int main(int argc, char **argv)
 {
-    configurationTy configuration;
+    int option;
+    while ((option = getopt(argc, argv, "c:p:n:s:w:")) != -1)
+    {
+        switch (option)
+        {
+        case 'c':
+            classCount = atoi(optarg);
+            break;
+        case 'p':
+            parentsPerClass = atoi(optarg);
+            break;
+        case 'n':
+            sampleCount = atoi(optarg);
+            break;
+        case 's':
+            sampleSeed = strtoul(optarg, NULL, 0);
+            break;
+        case 'w':
+            if (sscanf(optarg, "%d:%d", &nonVirtualWeight, &virtualWeight) != 2)
+            {
+                printUsage(argv[0]);
+                exit(-1);
+            }
+            break;
+        default:
+            printUsage(argv[0]);
+            exit(-1);
+        }
+    }
+    if (classCount < 1 || parentsPerClass < 0 || sampleCount < 0 ||
+        nonVirtualWeight < 0 || virtualWeight < 0)
+    {
+        printUsage(argv[0]);
+        exit(-1);
+    }
+    // Without parents or parent weights only single class hierarchies are connected
+    if (sampleCount > 0 && classCount > 1 &&
+        (parentsPerClass == 0 || nonVirtualWeight + virtualWeight == 0))
+    {
+        cerr << "Cannot sample connected hierarchies without parents." << endl;
+        exit(-1);
+    }
+
     int count = 0;
+    if (sampleCount > 0)
+    {
+        // Source file names are streamed on stdout, keep the summary apart
+        sampleHierarchyConfigurations(&count);
+        cerr << "Solutions found: " << count << endl;
+        return 0;
+    }
+    configurationTy configuration;
     generateHierarchyConfigurations(configuration, &count);
     cout << "Solutions found: " << count << endl;
     return 0;
@@ -74,7 +74,7 @@ int main(int argc, char **argv)
         mapSettingTy *mapSetting = callSiteMapEntry.second;
         total += mapSetting->size;
         covered += mapSetting->observedContents.size();
-        if (mapSetting->size != mapSetting->observedContents.size())
+        if ((unsigned long)mapSetting->size != mapSetting->observedContents.size())
         {
             cerr << "Not all map entries used" << endl;
             cerr << "Callsite: 0x" << hex << callSiteMapEntry.first << dec << endl;
@@ -1,5 +1,10 @@
 #include <iostream>
 #include <fstream>
+#include <math.h>
+#include <stdio.h>
+
+// Normal quantile of the reported two-sided confidence intervals (95%)
+#define CONFIDENCE_Z 1.96
 
 using namespace std;
 
@@ -7,6 +12,11 @@ int main(int argc, char **argv)
 {
     unsigned long allTotal = 0;
     unsigned long allCovered = 0;
+    // Per-sample statistics, each report line comes from one sampled hierarchy
+    unsigned long samples = 0;
+    unsigned long preciseSamples = 0;
+    double coverageSum = 0;
+    double coverageSquareSum = 0;
     // Read all call-site reports
     while (!cin.eof())
     {
@@ -20,7 +30,43 @@ int main(int argc, char **argv)
             continue;
         allTotal += total;
         allCovered += covered;
+        // Samples without checked call-sites carry no coverage information
+        if (total == 0)
+            continue;
+        double coverage = (double)covered / total;
+        ++samples;
+        coverageSum += coverage;
+        coverageSquareSum += coverage * coverage;
+        if (covered == total)
+            ++preciseSamples;
     }
     cerr << "Total number of entries found in VTable sets: " << allTotal << " Total number of entries used from VTable sets: " << allCovered << endl;
+    if (samples == 0)
+        return 0;
+    cerr << "Pooled coverage of VTable sets (used / found entries): " << (double)allCovered / allTotal << endl;
+
+    // Mean of the per-hierarchy coverage ratios with normal approximation of its confidence interval
+    // The interval needs the sample variance, so it is undefined for a single sample
+    double n = samples;
+    double mean = coverageSum / n;
+    cerr << "Per-hierarchy mean coverage of VTable sets over " << samples << " samples: " << mean;
+    if (samples > 1)
+    {
+        double variance = (coverageSquareSum - n * mean * mean) / (n - 1);
+        if (variance < 0)
+            variance = 0;
+        double margin = CONFIDENCE_Z * sqrt(variance / n);
+        cerr << " (95% CI " << fmax(0, mean - margin) << " - " << fmin(1, mean + margin) << ")" << endl;
+    }
+    else
+        cerr << " (95% CI undefined for a single sample)" << endl;
+
+    // Share of samples where every VTable set entry was used, with Wilson score interval
+    double z2 = CONFIDENCE_Z * CONFIDENCE_Z;
+    double share = preciseSamples / n;
+    double center = (share + z2 / (2 * n)) / (1 + z2 / n);
+    double spread = CONFIDENCE_Z * sqrt(share * (1 - share) / n + z2 / (4 * n * n)) / (1 + z2 / n);
+    cerr << "Samples with fully used VTable sets: " << preciseSamples << " of " << samples << ": " << share
+         << " (95% CI " << fmax(0, center - spread) << " - " << fmin(1, center + spread) << ")" << endl;
     return 0;
 }